@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013 Manolis Agkopian
+# See the file LICENCE for copying permission.
+#
+# Benchmarks every phase of the translator on a set of generated programs.
+# The front ends are built with TIMING_MODE enabled, so each translation
+# prints the median and 99th percentile of every phase as JSON on stderr.
+# Every program is also precompiled, and loading it is benchmarked under
+# the <front end>_ccb name, to compare with the text path. Its bytes are the
+# size of the .ccb file and its tokens are the optimized tokens, so compare
+# the two paths by their times, not by their tokens/sec.
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(BENCH_DIR)
+
+# name -> options of gen_program.py
+CASES = [
+    ('small', ['--lines', '20']),
+    ('medium', ['--lines', '150']),
+    ('large', ['--lines', '450']),
+    ('literals_only', ['--lines', '450', '--var-ratio', '0']),
+    ('zeros_and_pow2', ['--lines', '450', '--zeros', '0.3', '--pow2', '0.6', '--ops', '+-**//']),
+    ('dense_assignments', ['--lines', '450', '--assign', '0.5']),
+    ('invalid_lines', ['--lines', '450', '--invalid', '0.3']),
+    ('missing_eop', ['--lines', '450', '--no-eop']),
+    ('vars_26', ['--lines', '450', '--assign', '0.5', '--vars', '26']),
+    ('vars_100', ['--lines', '450', '--assign', '0.5', '--vars', '100']),
+    ('vars_220_long_names', ['--lines', '450', '--assign', '0.5', '--vars', '220', '--name-len', '12']),
+]
+
+
+def build(runs, build_dir):
+    """Builds the front ends with TIMING_MODE enabled, returns name -> binary."""
+    flags = ['gcc', '-O2', '-DTIMING_MODE=1', '-DTIMING_RUNS=%d' % runs]
+    binaries = {}
+
+    binary = os.path.join(build_dir, 'code_calc')
+    subprocess.check_call(flags + ['-o', binary, os.path.join(REPO_DIR, 'code_calc.c')])
+    binaries['code_calc'] = binary
+
+    if shutil.which('flex'):
+        source = os.path.join(build_dir, 'flex_code_calc.c')
+        binary = os.path.join(build_dir, 'flex_code_calc')
+        subprocess.check_call(['flex', '-o', source, os.path.join(REPO_DIR, 'flex_code_calc.l')])
+        subprocess.check_call(flags + ['-o', binary, source, '-lfl'])
+        binaries['flex_code_calc'] = binary
+    else:
+        sys.stderr.write('flex not found, skipping flex_code_calc\n')
+
+    return binaries
+
+
+def run_case(binary, program, output, mode=None):
+    """Translates a program, or loads a precompiled one with mode '--load-bin', and returns the timings it printed."""
+    proc = subprocess.run([binary] + ([mode] if mode else []) + [program, '-o', output],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, universal_newlines=True)
+    lines = [line for line in proc.stderr.splitlines() if line.startswith('{')]
+    if proc.returncode != 0 or not lines:
+        raise RuntimeError('%s failed on %s:\n%s' % (binary, program, proc.stderr))
+    return json.loads(lines[-1])
+
+
+def compare(baseline, results):
+    """Prints the change of the median total time of every case against a baseline."""
+    print('\n%-20s %-22s %12s %12s %8s' % ('front end', 'case', 'baseline ns', 'current ns', 'change'))
+    for frontend, cases in sorted(results.items()):
+        for case, result in cases.items():
+            try:
+                old = baseline[frontend][case]['total']['median_ns']
+            except KeyError:
+                continue
+            new = result['total']['median_ns']
+            print('%-20s %-22s %12d %12d %+7.1f%%' % (frontend, case, old, new, (new - old) * 100.0 / old))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark the translator phases on generated programs.')
+    parser.add_argument('--seed', type=int, default=1, help='seed of the generated programs (default: 1)')
+    parser.add_argument('--runs', type=int, default=200, help='times each phase is repeated (default: 200)')
+    parser.add_argument('--out', help='save the results as JSON in this file')
+    parser.add_argument('--baseline', help='compare against the results saved in this file')
+    args = parser.parse_args()
+
+    build_dir = tempfile.mkdtemp(prefix='code_calc_bench_')
+    try:
+        binaries = build(args.runs, build_dir)
+        results = {}
+
+        print('%-20s %-22s %7s %12s %12s %14s' % ('front end', 'case', 'tokens', 'median ns', 'p99 ns', 'tokens/sec'))
+        for name, options in CASES:
+            program = os.path.join(build_dir, name + '.txt')
+            subprocess.check_call([sys.executable, os.path.join(BENCH_DIR, 'gen_program.py'), '--seed', str(args.seed), '-o', program] + options)
+
+            for frontend, binary in sorted(binaries.items()):
+                # the text path, and then loading the same program precompiled
+                ccb = os.path.join(build_dir, name + '.ccb')
+                subprocess.check_call([binary, '--compile-bin', program, '-o', ccb], stdout=subprocess.DEVNULL)
+                runs = [(frontend, run_case(binary, program, os.path.join(build_dir, 'out.c'))),
+                        (frontend + '_ccb', run_case(binary, ccb, os.path.join(build_dir, 'out.c'), '--load-bin'))]
+
+                for key, result in runs:
+                    result['options'] = options
+                    results.setdefault(key, {})[name] = result
+                    print('%-20s %-22s %7d %12d %12d %14.0f' % (key, name, result['tokens'], result['total']['median_ns'],
+                                                              result['total']['p99_ns'], result['tokens_per_sec']))
+    finally:
+        shutil.rmtree(build_dir)
+
+    if args.out:
+        with open(args.out, 'w') as fp:
+            json.dump({'seed': args.seed, 'runs': args.runs, 'results': results}, fp, indent=2)
+
+    if args.baseline:
+        with open(args.baseline) as fp:
+            compare(json.load(fp)['results'], results)
+
+
+if __name__ == '__main__':
+    main()
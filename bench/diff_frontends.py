@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013 Manolis Agkopian
+# See the file LICENCE for copying permission.
+#
+# Runs the front ends on the same generated and mutated programs and checks
+# that they agree on the tokens, the diagnostics, the generated C and the
+# result printed by the generated C. Every divergence is minimized to a
+# small reproducer program.
+
+import argparse
+import os
+import random
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(BENCH_DIR)
+sys.path.insert(0, BENCH_DIR)
+
+import gen_program
+
+ASPECTS = ['tokens', 'diagnostics', 'code', 'result']
+
+
+def build(build_dir):
+    """Builds the front ends with DEBUG_MODE enabled, returns name -> binary."""
+    flags = ['gcc', '-DDEBUG_MODE=1']
+    binaries = {}
+
+    binary = os.path.join(build_dir, 'code_calc')
+    subprocess.check_call(flags + ['-o', binary, os.path.join(REPO_DIR, 'code_calc.c')])
+    binaries['code_calc'] = binary
+
+    if shutil.which('flex'):
+        source = os.path.join(build_dir, 'flex_code_calc.c')
+        binary = os.path.join(build_dir, 'flex_code_calc')
+        subprocess.check_call(['flex', '-o', source, os.path.join(REPO_DIR, 'flex_code_calc.l')])
+        subprocess.check_call(flags + ['-o', binary, source, '-lfl'])
+        binaries['flex_code_calc'] = binary
+    else:
+        sys.stderr.write('flex not found, skipping flex_code_calc\n')
+
+    return binaries
+
+
+def generate(rng):
+    """Returns a generated program, with random generator options."""
+    args = argparse.Namespace(seed=rng.randrange(1 << 30), lines=rng.randint(1, 60), ops=rng.choice(['+-*/%', '++--*', '*/%']),
+                              var_ratio=rng.random(), zeros=rng.random() * 0.3, pow2=rng.random() * 0.5,
+                              max_literal=rng.choice([10, 1000, 100000]), assign=rng.random() * 0.5,
+                              invalid=rng.random() * 0.2, vars=rng.randint(1, 40), name_len=rng.randint(1, 8),
+                              no_eop=rng.random() < 0.2)
+    return gen_program.generate(args)
+
+
+def mutate(rng, program):
+    """Returns the program with a few random mutations."""
+    lines = program.split('\n')
+    for _ in range(rng.randint(1, 4)):
+        i = rng.randrange(len(lines))
+        kind = rng.randrange(8)
+        if kind == 0:
+            del lines[i]
+        elif kind == 1:
+            lines.insert(i, lines[i])
+        elif kind == 2:
+            j = rng.randrange(len(lines))
+            lines[i], lines[j] = lines[j], lines[i]
+        elif kind == 3:
+            lines.insert(i, '')
+        elif kind == 4:
+            lines[i] = lines[i].replace(' ', rng.choice(['\t', '  ', ' \t', '']), 1)
+        elif kind == 5:
+            p = rng.randint(0, len(lines[i]))
+            lines[i] = lines[i][:p] + rng.choice(' \t;=+-*/%0123456789abcz_A#') + lines[i][p:]
+        elif kind == 6 and lines[i]:
+            p = rng.randrange(len(lines[i]))
+            lines[i] = lines[i][:p] + lines[i][p + 1:]
+        else:
+            lines[i] = lines[i] + rng.choice([' ', '\t', '  '])
+        if not lines:
+            lines = ['']
+    program = '\n'.join(lines)
+    return program.rstrip('\n') if rng.random() < 0.2 else program
+
+
+def run(binary, program, work_dir):
+    """Translates a program, returns aspect -> observed behaviour."""
+    source = os.path.join(work_dir, 'prog.txt')
+    output = os.path.join(work_dir, 'out.c')
+    with open(source, 'w') as fp:
+        fp.write(program)
+    if os.path.exists(output):
+        os.remove(output)
+
+    try:
+        proc = subprocess.run([binary, source, '-o', output], stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True, timeout=10)
+    except subprocess.TimeoutExpired:
+        return {'tokens': 'timeout', 'diagnostics': '', 'code': '', 'result': ''}
+    stdout = proc.stdout.replace(output, 'out.c')
+
+    debug = re.findall(r'^Phase [234]: .*?(?=^Phase |\Z)', stdout, re.M | re.S)
+    diagnostics = [line for line in stdout.splitlines() if re.match(r'^(\d+: (error|warning): |No Errors$|\d+ more errors|Empty input)', line)]
+    observed = {'tokens': ''.join(debug) + 'exit %d' % proc.returncode, 'diagnostics': '\n'.join(diagnostics), 'code': '', 'result': ''}
+
+    if os.path.exists(output):
+        with open(output) as fp:
+            observed['code'] = fp.read()
+        executable = os.path.join(work_dir, 'out')
+        compiled = subprocess.run(['gcc', '-w', '-o', executable, output], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        if compiled.returncode != 0:
+            observed['result'] = 'does not compile'
+        else:
+            try:
+                result = subprocess.run([executable], stdout=subprocess.PIPE, universal_newlines=True, timeout=10)
+                observed['result'] = '%sexit %d' % (result.stdout, result.returncode)
+            except subprocess.TimeoutExpired:
+                observed['result'] = 'timeout'
+
+    return observed
+
+
+def divergence(binaries, program, work_dir):
+    """Returns the first aspect the front ends disagree on, or None."""
+    observed = [run(binary, program, work_dir) for binary in binaries.values()]
+    for aspect in ASPECTS:
+        if any(o[aspect] != observed[0][aspect] for o in observed[1:]):
+            return aspect
+    return None
+
+
+def minimize(binaries, program, aspect, work_dir):
+    """Removes lines, and then characters, while the front ends still disagree on the same aspect."""
+    def diverges(candidate):
+        return divergence(binaries, candidate, work_dir) == aspect
+
+    lines = program.split('\n')
+    chunk = len(lines) // 2
+    while chunk >= 1:
+        i = 0
+        while i < len(lines):
+            candidate = lines[:i] + lines[i + chunk:]
+            if candidate and diverges('\n'.join(candidate)):
+                lines = candidate
+            else:
+                i += chunk
+        chunk //= 2
+
+    for n in range(len(lines)):
+        p = 0
+        while p < len(lines[n]):
+            candidate = lines[:n] + [lines[n][:p] + lines[n][p + 1:]] + lines[n + 1:]
+            if diverges('\n'.join(candidate)):
+                lines = candidate
+            else:
+                p += 1
+
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check that the front ends of the translator agree.')
+    parser.add_argument('--seed', type=int, default=1, help='random seed (default: 1)')
+    parser.add_argument('--programs', type=int, default=200, help='number of programs to try (default: 200)')
+    parser.add_argument('--binary', action='append', default=[], metavar='NAME=PATH',
+                        help='also check a prebuilt front end, built with -DDEBUG_MODE=1 (can be repeated)')
+    parser.add_argument('--out-dir', default='diff_repro', help='where the reproducers are saved (default: diff_repro)')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    build_dir = tempfile.mkdtemp(prefix='code_calc_diff_')
+    divergences = 0
+    try:
+        binaries = build(build_dir)
+        for spec in args.binary:
+            name, path = spec.split('=', 1)
+            binaries[name] = os.path.abspath(path)
+        if len(binaries) < 2:
+            sys.exit('at least two front ends are needed, install flex or add one with --binary')
+
+        for n in range(args.programs):
+            program = generate(rng)
+            if rng.random() < 0.5:
+                program = mutate(rng, program)
+
+            aspect = divergence(binaries, program, build_dir)
+            if aspect is None:
+                continue
+
+            divergences += 1
+            reproducer = minimize(binaries, program, aspect, build_dir)
+            os.makedirs(args.out_dir, exist_ok=True)
+            path = os.path.join(args.out_dir, 'repro_%d_%s.txt' % (n, aspect))
+            with open(path, 'w') as fp:
+                fp.write(reproducer)
+            print('program %d: the front ends disagree on the %s, reproducer saved in %s:' % (n, aspect, path))
+            print('    ' + repr(reproducer))
+    finally:
+        shutil.rmtree(build_dir)
+
+    print('%d programs, %d divergences between %s' % (args.programs, divergences, ', '.join(sorted(binaries))))
+    sys.exit(1 if divergences else 0)
+
+
+if __name__ == '__main__':
+    main()
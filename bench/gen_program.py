@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2013 Manolis Agkopian
+# See the file LICENCE for copying permission.
+#
+# Generates random input programs for the translator. The same seed and
+# options always produce the same program.
+
+import argparse
+import random
+import sys
+
+MAX_TOKENS = 498  # the translator keeps 2 of its 500 token slots for the EOP and the result assignment
+MAX_BYTES = 9998  # the translator reads at most 9998 characters
+
+INVALID_LINES = ['? 3', '+3', '= 5', '+ 3 4', 'foo bar', '* A', '/ -2', '==', '+ a1', '% _']
+
+
+def var_name(i, length):
+    """Returns the i-th variable name, padded to the given length."""
+    name = ''
+    while True:
+        name = chr(ord('a') + i % 26) + name
+        i //= 26
+        if i == 0:
+            break
+    return name.rjust(length, 'a')
+
+
+def literal(rng, args):
+    """Returns a literal, following the zeros and powers of two ratios."""
+    r = rng.random()
+    if r < args.zeros:
+        return 0
+    if r < args.zeros + args.pow2:
+        return 2 ** rng.randint(0, 10)
+    return rng.randint(0, args.max_literal)
+
+
+def generate(args):
+    rng = random.Random(args.seed)
+    name_len = max(args.name_len, len(var_name(args.vars - 1, 1)))
+    names = [var_name(i, name_len) for i in range(args.vars)]
+    assigned = []  # only variables that have been assigned can be used, or the generated C would not compile
+    lines = []
+
+    for _ in range(args.lines):
+        r = rng.random()
+        if r < args.invalid:
+            lines.append(rng.choice(INVALID_LINES))
+        elif r < args.invalid + args.assign:
+            name = names[len(assigned) % len(names)] if len(assigned) < len(names) else rng.choice(names)
+            if name not in assigned:
+                assigned.append(name)
+            lines.append('= ' + name)
+        else:
+            op = rng.choice(args.ops)
+            if assigned and rng.random() < args.var_ratio:
+                lines.append('%s %s' % (op, rng.choice(assigned)))
+            else:
+                lines.append('%s %d' % (op, literal(rng, args)))
+
+    if not args.no_eop:
+        lines.append('=')
+
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a random input program for the translator.')
+    parser.add_argument('--seed', type=int, default=1, help='random seed (default: 1)')
+    parser.add_argument('--lines', type=int, default=100, help='number of lines before the EOP (default: 100)')
+    parser.add_argument('--ops', default='+-*/%', help='operators to choose from, repeat one to make it more frequent (default: +-*/%%)')
+    parser.add_argument('--var-ratio', type=float, default=0.3, help='ratio of operands that are variables (default: 0.3)')
+    parser.add_argument('--zeros', type=float, default=0.05, help='ratio of literals that are 0 (default: 0.05)')
+    parser.add_argument('--pow2', type=float, default=0.2, help='ratio of literals that are powers of 2 (default: 0.2)')
+    parser.add_argument('--max-literal', type=int, default=1000, help='maximum value of the other literals (default: 1000)')
+    parser.add_argument('--assign', type=float, default=0.1, help='ratio of lines that are assignments (default: 0.1)')
+    parser.add_argument('--invalid', type=float, default=0.0, help='ratio of lines that are invalid (default: 0)')
+    parser.add_argument('--vars', type=int, default=26, help='number of distinct variables (default: 26)')
+    parser.add_argument('--name-len', type=int, default=1, help='minimum length of the variable names (default: 1)')
+    parser.add_argument('--no-eop', action='store_true', help='leave out the END_OF_PROGRAM line')
+    parser.add_argument('-o', dest='output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    program = generate(args)
+
+    if program.count('\n') > MAX_TOKENS or len(program) > MAX_BYTES:
+        sys.stderr.write('warning: the program is over the translator limits (%d lines, %d bytes)\n' % (MAX_TOKENS, MAX_BYTES))
+
+    if args.output:
+        with open(args.output, 'w') as fp:
+            fp.write(program)
+    else:
+        sys.stdout.write(program)
+
+
+if __name__ == '__main__':
+    main()
@@ -10,15 +10,39 @@
 #include <stdlib.h>  
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+#ifndef DEBUG_MODE
 #define DEBUG_MODE 0
+#endif
 
-#define VALINE "^[ 	]*\\(\\(\\([*]\\|[+]\\|[-]\\|[/]\\|[%]\\)\\([ 	]\\+\\)\\(\\([0-9]\\+\\)\\|\\([a-z]\\)\\)\\)\\|\\([=][ 	]\\+[a-z]\\)\\|\\([=]\\)\\)[ 	]*$"
+#ifndef TIMING_MODE
+#define TIMING_MODE 0
+#endif
+
+#ifndef TIMING_RUNS
+#define TIMING_RUNS 100 //number of times the phases are repeated in TIMING_MODE
+#endif
+
+#define VALINE "^[ 	]*\\(\\(\\([*]\\|[+]\\|[-]\\|[/]\\|[%]\\)\\([ 	]\\+\\)\\(\\([0-9]\\+\\)\\|\\([a-z]\\{1,31\\}\\)\\)\\)\\|\\([=][ 	]\\+[a-z]\\{1,31\\}\\)\\|\\([=]\\)\\)[ 	]*$"
 #define BRACKET 1
 #define NO_BRACKET 0
+#define MAX_ERRORS 100 //maximum number of diagnostics that are kept
+#define EXCERPT_LEN 40 //maximum number of characters of a rejected line that a diagnostic keeps
+#define MAX_NAME_LEN 31 //maximum length of a variable name, VALINE has the same limit
+#define MAX_VARS 512 //maximum number of distinct variables, a program can't have more than 500 tokens anyway
+#define VAR_TABLE_SIZE 1024 //size of the symbol table, a power of 2 greater than MAX_VARS
+#define RESULT_VAR 0 //id of the default variable
+#define CODE_SIZE 40000 //size of the generated code buffer
+#define MAX_TOKENS 500 //maximum number of tokens of a program
+#define FNV_OFFSET 2166136261u //initial value of a FNV-1a hash
+#define CCB_MAGIC "CCB" //first bytes of a precompiled program file, including the '\0'
+#define CCB_VERSION 1 //version of the precompiled program file format
 
-char error_buffer[2000];
-int error_cnt = 0;
 int removed_lines = 1; //set it to 1 and not 0 because for user first line is 1
 
 /**************************************************************
@@ -39,10 +63,45 @@ typedef struct {
 	token_operation operation; //t_plus | t_min | t_mul | t_div | t_shl | t_shr | t_assign | t_end
 	union {
 		int value; //for literals only
-		char name; //for variables only
+		int id; //for variables only, the id of the interned variable name
 	} data; //eop carries no data
 } token;
 
+/*Diagnostic code declaration, e_ codes are errors and w_ codes are warnings*/
+typedef enum {e_unrecognised_token = 300, e_missing_eop, w_division_by_zero = 400, w_unreachable_code} diagnostic_code;
+
+/*Diagnostic struct declaration*/
+typedef struct {
+	diagnostic_code code; //e_unrecognised_token | e_missing_eop | w_division_by_zero | w_unreachable_code
+	int line; //the line of the input file the diagnostic refers to
+	int text_len; //for e_unrecognised_token only, the length of the rejected line
+	char text[EXCERPT_LEN + 1]; //for e_unrecognised_token only, the start of the rejected line
+} diagnostic;
+
+/*Run mode declaration, set by the first argument*/
+typedef enum {translate = 500, compile_bin, load_bin} run_mode;
+
+/*Header of a precompiled program file (.ccb), followed by the tokens and then by the variable names*/
+typedef struct {
+	char magic[4]; //always CCB_MAGIC
+	int version; //CCB_VERSION
+	int token_size; //sizeof(token), a file can only be loaded where the tokens have the same layout
+	int name_size; //size of each variable name entry, MAX_NAME_LEN + 2
+	int tokens_cnt; //number of tokens
+	int vars_cnt; //number of variable names
+	unsigned int checksum; //FNV-1a hash of the tokens and the variable names
+} ccb_header;
+
+diagnostic diagnostics[MAX_ERRORS]; //the logged diagnostics, they are printed at the end of the translation
+int error_cnt = 0; //total number of diagnostics, including the ones that did not fit in the log
+int max_errors = MAX_ERRORS; //number of diagnostics to keep, can be lowered with --max-errors
+char var_names_table[MAX_VARS][MAX_NAME_LEN + 2] = {"result"}; //the interned variable names, as used in the generated code
+char (*var_names)[MAX_NAME_LEN + 2] = var_names_table; //the variable names in use, points inside a loaded precompiled program
+int var_cnt = 1; //number of interned variables, the default variable is always interned
+int var_table[VAR_TABLE_SIZE]; //open addressing hash table with the ids of the interned names, 0 marks an empty slot
+char *ccb_map = NULL; //mapping of the loaded precompiled program
+size_t ccb_size = 0; //size of the mapping
+
 /*Checks if a line of code is valid using a regex*/
 int is_valid_line (char *line);
 
@@ -58,6 +117,15 @@ int extract_tokens (char *buffer, token *tokens);
 /*Takes a line of valid code and extracts the token from it*/
 token scan_one_token (char *line);
 
+/*Continues a FNV-1a hash h over len bytes of data, start with h = FNV_OFFSET*/
+unsigned int hash_bytes (unsigned int h, char *data, int len);
+
+/*Checks if a variable name clashes with a C keyword or a name used by the generated code*/
+int is_reserved_name (char *name);
+
+/*Interns a variable name of len characters into the symbol table and returns its id*/
+int intern_name (char *name, int len);
+
 /*Print the tokens from a token array (for debugging usage)*/
 void print_tokens (token *tokens, int t);
 
@@ -68,7 +136,7 @@ int analize_tokens (token *tokens, int t);
 int optimize_tokens (token *tokens, int t);
 
 /*Checks if an integer is power for two from 0 to 10*/
-inline int is_power_of_2 (int x);
+static inline int is_power_of_2 (int x);
 
 /*Return shift equiv for power of two div or mul*/
 int shift_times (int x);
@@ -82,26 +150,122 @@ void token_to_code (token tkn, char *code_token, int put_bracket);
 /*Generates the assignments lines of the C code*/
 int generate_assignments (token *tokens, int t, char *assign_buff);
 
+/*Write the code on a file, without any fallback or messages*/
+int write_code (char *buffer, char *fname);
+
 /*Save users code on an output file*/
 int save_code(char *buffer, char *fname);
 
+/*Log a diagnostic to the global diagnostics log*/
+void log_diagnostic (diagnostic_code code, int line, char *text);
+
+/*Print the logged diagnostics*/
+void print_diagnostics (void);
+
+/*Returns the nanoseconds elapsed between two readings of the monotonic clock*/
+long long elapsed_ns (struct timespec *start, struct timespec *end);
+
+/*Compares two timings, used by qsort*/
+int compare_ns (const void *a, const void *b);
+
+/*Print the median and the 99th percentile of a phase timings as a JSON member*/
+void print_timing (char *name, long long *ns, int runs);
+
+/*Run all the phases of the translation TIMING_RUNS times and print their timings as JSON on stderr*/
+void benchmark_phases (char *in_fname, char *out_fname);
+
+/*Save the optimized tokens of a program in a precompiled program file*/
+int save_program (token *tokens, int t, char *fname);
+
+/*Map a precompiled program file in memory, returns the number of tokens or -1 if the file is not valid*/
+int load_program (char *fname, token **tokens);
+
+/*Unmap the last loaded precompiled program*/
+void unload_program (void);
+
+/*Load a precompiled program and generate its code TIMING_RUNS times and print the timings as JSON on stderr*/
+void benchmark_load (char *in_fname, char *out_fname);
+
+/*Print the timings of a benchmark as a JSON line on stderr, the last row of ns is the total time*/
+void print_benchmark (char *in_fname, char **phases, int phases_cnt, long long (*ns)[TIMING_RUNS], int bytes, int tokens_cnt);
+
 int main (int argc, char *argv[]) {
-	char buffer[10000];
-	token tokens[500];
+	char buffer[CODE_SIZE];
+	token tokens[MAX_TOKENS];
+	token *program; //the tokens of a loaded precompiled program
 	int t; //total number of tokens
 	int i; //general use counter
 	int res;
+	run_mode mode = translate;
+	int in = 1; //position of the input file name in argv
+	long n; //value of a numeric argument
+	char *end; //end of a numeric argument
 	FILE *fp;
+	char *out_fname = "out.c"; //the output file name
+	
+	/*Check if user asked to create or to load a precompiled program*/
+	if (argc > 2 && strcmp(argv[1], "--compile-bin") == 0) {
+		mode = compile_bin;
+		out_fname = "out.ccb";
+		in = 2;
+	}
+	else if (argc > 2 && strcmp(argv[1], "--load-bin") == 0) {
+		mode = load_bin;
+		in = 2;
+	}
 	
 	if (argc < 2) { //check if the number of arguments is correct
-		printf("Usage: %s <input_file> -o <output_file>\n", argv[0]);
+		printf("Usage: %s <input_file> -o <output_file> --max-errors <number>\n", argv[0]);
+		printf("       %s --compile-bin <input_file> -o <output_file.ccb> --max-errors <number>\n", argv[0]);
+		printf("       %s --load-bin <input_file.ccb> -o <output_file>\n", argv[0]);
 		return 1;
 	}
-	else if ((fp = fopen(argv[1], "r")) == NULL) { //try to open the input file
+	else if (mode == load_bin) {
+		/*Parse the optional arguments*/
+		for (i = in + 1; i + 1 < argc; i += 2) {
+			if (strcmp(argv[i], "-o") == 0) { //check if user provided output file name
+				out_fname = argv[i + 1];
+			}
+		}
+		
+		/*Map the precompiled program and generate the code straight from the mapped tokens*/
+		if ((t = load_program(argv[in], &program)) == -1) {
+			return 4;
+		}
+		
+		generate_code(buffer, program, t);
+		save_code(buffer, out_fname);
+		
+		/*If is on TIMING_MODE load the program again a number of times and print how long each phase takes*/
+		if (TIMING_MODE) {
+			unload_program();
+			benchmark_load(argv[in], out_fname);
+		}
+		
+		return 0;
+	}
+	else if ((fp = fopen(argv[in], "r")) == NULL) { //try to open the input file
 		printf("%s\n", strerror(errno));
 		return 2;
 	}
 	else {
+		/*Parse the optional arguments*/
+		for (i = in + 1; i + 1 < argc; i += 2) {
+			if (strcmp(argv[i], "-o") == 0) { //check if user provided output file name
+				out_fname = argv[i + 1];
+			}
+			else if (strcmp(argv[i], "--max-errors") == 0) { //check if user provided the number of diagnostics to keep
+				n = strtol(argv[i + 1], &end, 10);
+				
+				if (argv[i + 1][0] == '\0' || *end != '\0' || n < 0 || n > MAX_ERRORS) {
+					printf("The number of errors to display must be between 0 and %d.\n", MAX_ERRORS);
+					fclose(fp);
+					return 1;
+				}
+				max_errors = n;
+			}
+		}
+		
 		/*Phase 0: Put instuctions from the input file to the buffer serialized*/
 		res = serialize_input(buffer, fp);
 		
@@ -110,7 +274,7 @@ int main (int argc, char *argv[]) {
 			printf("Phase 0: Put instuctions from the input file to the buffer serialized:\n%s\n\n", buffer);
 		}
 		
-		close(fp);
+		fclose(fp);
 		if (res == 0) {
 			puts("Empty input file.");
 			return 3;
@@ -155,28 +319,35 @@ int main (int argc, char *argv[]) {
 		putchar('\n');
 	}
 	
-	/*Phase 5: Do code generation based on the tokens*/
-	generate_code(buffer, tokens, t);
-	
-	/*If is on DEBUG_MODE print debuggin info*/
-	if (DEBUG_MODE) {
-		printf("Phase 5: Do code generation based on the tokens:\n%s\n\n", buffer);
+	/*Phase 5: Do code generation based on the tokens, a precompiled program keeps the tokens instead*/
+	if (mode == translate) {
+		generate_code(buffer, tokens, t);
+		
+		/*If is on DEBUG_MODE print debuggin info*/
+		if (DEBUG_MODE) {
+			printf("Phase 5: Do code generation based on the tokens:\n%s\n\n", buffer);
+		}
 	}
 	
-	/*Print errors buffer*/
+	/*Print the diagnostics log*/
 	if (error_cnt != 0) {
-		puts(error_buffer);
+		print_diagnostics();
 	}
 	else {
 		puts("No Errors");
 	}
 	
-	/*Final Phase: Save the code in a file*/
-	if (argc == 4 && strcmp(argv[2], "-o") == 0) { //check if user provided output file name
-		save_code(buffer, argv[3]);
+	/*Final Phase: Save the code, or the precompiled program, in a file*/
+	if (mode == compile_bin) {
+		save_program(tokens, t, out_fname);
 	}
 	else {
-		save_code(buffer, "out.c");
+		save_code(buffer, out_fname);
+	}
+	
+	/*If is on TIMING_MODE run the translation again a number of times and print how long each phase takes*/
+	if (TIMING_MODE && mode == translate) {
+		benchmark_phases(argv[in], out_fname);
 	}
 	
 	return 0;
@@ -185,63 +356,77 @@ int main (int argc, char *argv[]) {
 /*Checks if a line of code is valid using a regex*/
 int is_valid_line (char *line) {
 	int regres; //the result of regex
-	regex_t regex; //the regular expretion
-	char *regerr; //regex error buffer
+	static regex_t regex; //the regular expretion, compiled only on the first call
+	static int regex_compiled = 0;
+	char regerr[100]; //regex error buffer
+	
+	if (!regex_compiled) {
+		regres = regcomp(&regex, VALINE, 0); //compile the regex
+		
+		if (regres) {
+			regerror(regres, &regex, regerr, sizeof(regerr));
+			fputs(regerr, stderr);
+			exit(-1);
+		}
+		regex_compiled = 1;
+	}
 	
-	regres = regcomp(&regex, VALINE, 0); //compile the regex
 	regres = regexec(&regex, line, 0, NULL, 0); //execute regex
 	
 	if (!regres){
-		regfree(&regex); //free the compiled regex
 		return 1; //line is accepted
 	}
 	else if (regres == REG_NOMATCH){
-		regfree(&regex); //free the compiled regex
 		return 0; //line is not accepted
 	}
 	else{
-		regfree(&regex); //free the compiled regex
 		regerror(regres, &regex, regerr, sizeof(regerr));
 		fputs(regerr, stderr);
 		exit(-1);
 	}
 }
 
-/*Gets the instuctions from the input file and validates them*/
+/*Gets the instuctions from the input file and serialezes them*/
 int serialize_input (char *buffer, FILE *fp) {
-	int i = 0; //lines counter
-	int j;
-	int line_len;
+	int len; //number of characters read from the input file
+	int i; //read position counter
+	int k = 0; //serialized buffer counter
 	
-	for(i = 0; !feof(fp); i += line_len) {
-		fgets(&buffer[i], 1000, fp); //max 1000 chars each line
-		line_len = strlen(&buffer[i]);
-		
-		//discard null lines
-		if (line_len == 1) {
-			line_len = 0;
-			++removed_lines;
-			continue;
-		}
-		
-		/*Replace semicolons in the source code with an invalid character so we won't have problems later*/
-		for (j = 0; j < line_len; ++j) {
-			if (buffer[i + j] == ';') {
-				buffer[i + j] = '#';
+	/*Read the whole input file with a single call and serialize it in place*/
+	len = fread(buffer, 1, 9998, fp); //max 9998 chars, leave room for the last ';' and the '\0'
+	
+	if (len == 9998 && fgetc(fp) != EOF) { //the input file doesn't fit in the buffer, don't translate only a part of it
+		fputs("Error! Input file too large.", stderr);
+		exit(-3);
+	}
+	
+	for (i = 0; i < len; ++i) {
+		if (buffer[i] == '\n') {
+			if (k == 0 || buffer[k - 1] == ';') { //discard null lines
+				++removed_lines;
 			}
-		}
-		
-		/*Replace all tabs with spaces*/
-		for (j = 0; j < line_len; ++j) {
-			if (buffer[i + j] == '\t') {
-				buffer[i + j] = ' ';
+			else {
+				buffer[k++] = ';'; //put ';' delimiter at the end of line
 			}
 		}
-		
-		//put ';' delimiter at the end of line
-		buffer[i + line_len - 1] = ';';
+		else if (buffer[i] == ';') { //replace semicolons in the source code with an invalid character so we won't have problems later
+			buffer[k++] = '#';
+		}
+		else if (buffer[i] == '\t') { //replace all tabs with spaces
+			buffer[k++] = ' ';
+		}
+		else {
+			buffer[k++] = buffer[i];
+		}
 	}
-	return i;
+	
+	/*If the last line has no new line character put the ';' delimiter at the end of it*/
+	if (k > 0 && buffer[k - 1] != ';') {
+		buffer[k++] = ';';
+	}
+	buffer[k] = '\0';
+	
+	return k;
 }
 
 /*Validate the tokens in each line and make sure only valid tokens exist*/
@@ -276,9 +461,8 @@ int validate_tokens (char *buffer) {
 			}
 			else {
 				noerror = 0;
-				//log the error to the global error buffer
-				sprintf(&error_buffer[error_cnt], "%d: error: unrecognised token `%s`\n", ln + removed_lines, line);
-				error_cnt += strlen(&error_buffer[error_cnt]);
+				//log the error to the global diagnostics log
+				log_diagnostic(e_unrecognised_token, ln + removed_lines, line);
 			}
 			++ln;
 		}
@@ -286,6 +470,7 @@ int validate_tokens (char *buffer) {
 	
 	removed_lines += ln - l;
 	
+	tmp[k] = '\0'; //terminate the valid lines, tmp is not initialized
 	strcpy(buffer, tmp);
 	return noerror;
 }
@@ -306,6 +491,11 @@ int extract_tokens (char *buffer, token *tokens) {
 			line[j] = '\0';
 			j = 0;
 			
+			if (t == MAX_TOKENS - 2) { //analize_tokens may add 2 more tokens, the eop and the result assignment
+				fputs("Error! Too many tokens.", stderr);
+				exit(-3);
+			}
+			
 			tokens[t++] = scan_one_token(line);
 			if (tokens[t-1].type == invalid) { //this should never happen
 				--t;
@@ -325,10 +515,8 @@ token scan_one_token (char *line) {
 	int i;
 	int s;
 	
-	if (!is_valid_line(line)) { //if validate_tokens function works as expected this should never happen, just in case
-		tkn.type = invalid;
-		return tkn;
-	}
+	/*The line has already been checked against VALINE by validate_tokens, so it is not validated again here*/
+	tkn.type = invalid;
 
 	for (s = 0; line[s] == ' '; ++s); //drop spaces on the start of line
 	op = line[s]; //get the operator character
@@ -352,6 +540,8 @@ token scan_one_token (char *line) {
 		case '=':
 			tkn.operation = t_assign; //or t_end we will find out later
 			break;
+		default:
+			return tkn; //this should never happen, just in case
 	}
 	
 	for (++s; line[s] == ' '; ++s); //drop spaces on the start of line
@@ -359,12 +549,14 @@ token scan_one_token (char *line) {
 	if (line[s] == '\0') { //then we have a t_end, so...
 		tkn.operation = t_end;
 		tkn.type = eop;
-		//eop has no data
+		tkn.data.value = 0; //eop has no data, but it is written in the precompiled program files
 	}
 	else if (line[s] >= 'a' && line[s] <= 'z') { //then we have a type of variable
+		for (i = 0; line[s + i] >= 'a' && line[s + i] <= 'z'; ++i); //find the length of the name
+		
 		//operation has been set in the switch
 		tkn.type = variable;
-		tkn.data.name = line[s];	
+		tkn.data.id = intern_name(&line[s], i);
 	}
 	else if (line[s] >= '0' && line[s] <= '9') {
 		for (i = 0; line[s] >= '0' && line[s] <= '9'; num[i] = line[s], ++i, ++s); //parse the number
@@ -382,6 +574,72 @@ token scan_one_token (char *line) {
 	return tkn;
 }
 
+/*Continues a FNV-1a hash h over len bytes of data, start with h = FNV_OFFSET*/
+unsigned int hash_bytes (unsigned int h, char *data, int len) {
+	int i;
+	
+	for (i = 0; i < len; ++i) {
+		h ^= (unsigned char) data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*Checks if a variable name clashes with a C keyword or a name used by the generated code*/
+int is_reserved_name (char *name) {
+	static char *reserved[] = {
+		"result", "printf", "asm", "auto", "break", "case", "char", "const", "continue", "default", "do", "double",
+		"else", "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register", "restrict",
+		"return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef", "typeof", "union",
+		"unsigned", "void", "volatile", "while", NULL
+	};
+	int i;
+	
+	for (i = 0; reserved[i] != NULL; ++i) {
+		if (strcmp(name, reserved[i]) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*Interns a variable name of len characters into the symbol table and returns its id*/
+int intern_name (char *name, int len) {
+	unsigned int h;
+	int id;
+	
+	if (len > MAX_NAME_LEN) { //VALINE makes sure this never happens, just in case
+		len = MAX_NAME_LEN;
+	}
+	
+	/*Look the name up, using linear probing*/
+	for (h = hash_bytes(FNV_OFFSET, name, len) & (VAR_TABLE_SIZE - 1); var_table[h] != 0; h = (h + 1) & (VAR_TABLE_SIZE - 1)) {
+		id = var_table[h];
+		
+		//reserved names are stored with a '_' suffix, names in the input never contain a '_'
+		if (strncmp(var_names[id], name, len) == 0 && (var_names[id][len] == '\0' || strcmp(&var_names[id][len], "_") == 0)) {
+			return id; //the name has already been interned
+		}
+	}
+	
+	if (var_cnt == MAX_VARS) { //this should never happen, a program has less tokens than MAX_VARS
+		fputs("Error! Too many variables.", stderr);
+		exit(-4);
+	}
+	
+	/*Add the name to the symbol table*/
+	id = var_cnt++;
+	strncpy(var_names[id], name, len);
+	var_names[id][len] = '\0';
+	
+	if (is_reserved_name(var_names[id])) { //rename the variable, so the generated code compiles
+		strcat(var_names[id], "_");
+	}
+	
+	var_table[h] = id;
+	return id;
+}
+
 /*Print the tokens from a token array (for debugging usage)*/
 void print_tokens (token *tokens, int t) {
 	int i;
@@ -439,7 +697,7 @@ void print_tokens (token *tokens, int t) {
 			printf("type: %s\toperation: %s\tdata: %d\n", token_char[0], token_char[1], tokens[i].data.value);
 		}
 		else if (tokens[i].type == variable) {
-			printf("type: %s\toperation: %s\tdata: %c\n", token_char[0], token_char[1], tokens[i].data.name);
+			printf("type: %s\toperation: %s\tdata: %s\n", token_char[0], token_char[1], var_names[tokens[i].data.id]);
 		}
 		else {
 			printf("type: %s\toperation: %s\n", token_char[0], token_char[1]);
@@ -447,6 +705,329 @@ void print_tokens (token *tokens, int t) {
 	}
 }
 
+/*Returns the nanoseconds elapsed between two readings of the monotonic clock*/
+long long elapsed_ns (struct timespec *start, struct timespec *end) {
+	return (long long) (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+}
+
+/*Compares two timings, used by qsort*/
+int compare_ns (const void *a, const void *b) {
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+	
+	return (x > y) - (x < y);
+}
+
+/*Print the median and the 99th percentile of a phase timings as a JSON member*/
+void print_timing (char *name, long long *ns, int runs) {
+	qsort(ns, runs, sizeof(long long), compare_ns);
+	fprintf(stderr, "\"%s\": {\"median_ns\": %lld, \"p99_ns\": %lld}", name, ns[runs / 2], ns[(runs * 99 + 99) / 100 - 1]);
+}
+
+/*Run all the phases of the translation TIMING_RUNS times and print their timings as JSON on stderr*/
+void benchmark_phases (char *in_fname, char *out_fname) {
+	static char *phases[] = {"serialize_input", "validate_tokens", "extract_tokens", "analize_tokens", "optimize_tokens", "generate_code", "write_code"};
+	static char buffer[CODE_SIZE];
+	static token tokens[MAX_TOKENS];
+	static long long ns[8][TIMING_RUNS]; //the timings of each run, one row for every phase and one for the whole translation
+	struct timespec ts[8]; //the clock readings between the phases
+	FILE *fp;
+	int run, i;
+	int bytes = 0; //size of the serialized input
+	int tokens_cnt = 0; //number of tokens extracted from the input
+	
+	if ((fp = fopen(in_fname, "r")) == NULL) {
+		fprintf(stderr, "%s\n", strerror(errno));
+		return;
+	}
+	
+	for (run = 0; run < TIMING_RUNS; ++run) {
+		/*Reset the global state, so every run does the same work*/
+		rewind(fp);
+		removed_lines = 1;
+		error_cnt = 0;
+		var_cnt = 1;
+		memset(var_table, 0, sizeof(var_table));
+		
+		clock_gettime(CLOCK_MONOTONIC, &ts[0]);
+		bytes = serialize_input(buffer, fp);
+		clock_gettime(CLOCK_MONOTONIC, &ts[1]);
+		validate_tokens(buffer);
+		clock_gettime(CLOCK_MONOTONIC, &ts[2]);
+		tokens_cnt = extract_tokens(buffer, tokens);
+		clock_gettime(CLOCK_MONOTONIC, &ts[3]);
+		i = analize_tokens(tokens, tokens_cnt);
+		clock_gettime(CLOCK_MONOTONIC, &ts[4]);
+		i = optimize_tokens(tokens, i);
+		clock_gettime(CLOCK_MONOTONIC, &ts[5]);
+		generate_code(buffer, tokens, i);
+		clock_gettime(CLOCK_MONOTONIC, &ts[6]);
+		write_code(buffer, out_fname);
+		clock_gettime(CLOCK_MONOTONIC, &ts[7]);
+		
+		for (i = 0; i < 7; ++i) {
+			ns[i][run] = elapsed_ns(&ts[i], &ts[i + 1]);
+		}
+		ns[7][run] = elapsed_ns(&ts[0], &ts[7]);
+	}
+	fclose(fp);
+	
+	print_benchmark(in_fname, phases, 7, ns, bytes, tokens_cnt);
+}
+
+/*Load a precompiled program and generate its code TIMING_RUNS times and print the timings as JSON on stderr*/
+void benchmark_load (char *in_fname, char *out_fname) {
+	static char *phases[] = {"load_program", "generate_code", "write_code"};
+	static char buffer[CODE_SIZE];
+	static long long ns[4][TIMING_RUNS]; //the timings of each run, one row for every phase and one for the whole run
+	struct timespec ts[4]; //the clock readings between the phases
+	token *program;
+	int run, i;
+	int t = 0; //number of tokens of the program, these are the optimized tokens, not the extracted ones like in benchmark_phases
+	int size = 0; //size of the whole file, the header, the tokens and the names
+	
+	for (run = 0; run < TIMING_RUNS; ++run) {
+		clock_gettime(CLOCK_MONOTONIC, &ts[0]);
+		if ((t = load_program(in_fname, &program)) == -1) {
+			return;
+		}
+		size = (int) ccb_size;
+		clock_gettime(CLOCK_MONOTONIC, &ts[1]);
+		generate_code(buffer, program, t);
+		clock_gettime(CLOCK_MONOTONIC, &ts[2]);
+		write_code(buffer, out_fname);
+		clock_gettime(CLOCK_MONOTONIC, &ts[3]);
+		unload_program();
+		
+		for (i = 0; i < 3; ++i) {
+			ns[i][run] = elapsed_ns(&ts[i], &ts[i + 1]);
+		}
+		ns[3][run] = elapsed_ns(&ts[0], &ts[3]);
+	}
+	
+	print_benchmark(in_fname, phases, 3, ns, size, t);
+}
+
+/*Print the timings of a benchmark as a JSON line on stderr, the last row of ns is the total time*/
+void print_benchmark (char *in_fname, char **phases, int phases_cnt, long long (*ns)[TIMING_RUNS], int bytes, int tokens_cnt) {
+	int i;
+	long long total;
+	
+	fprintf(stderr, "{\"input\": \"%s\", \"runs\": %d, \"bytes\": %d, \"tokens\": %d, \"phases\": {", in_fname, TIMING_RUNS, bytes, tokens_cnt);
+	for (i = 0; i < phases_cnt; ++i) {
+		print_timing(phases[i], ns[i], TIMING_RUNS);
+		fputs(i < phases_cnt - 1 ? ", " : "}, ", stderr);
+	}
+	print_timing("total", ns[phases_cnt], TIMING_RUNS);
+	
+	total = ns[phases_cnt][TIMING_RUNS / 2] > 0 ? ns[phases_cnt][TIMING_RUNS / 2] : 1; //the median, ns is sorted by print_timing
+	fprintf(stderr, ", \"tokens_per_sec\": %.0f, \"bytes_per_sec\": %.0f}\n", tokens_cnt * 1e9 / total, bytes * 1e9 / total);
+}
+
+/*Save the optimized tokens of a program in a precompiled program file*/
+int save_program (token *tokens, int t, char *fname) {
+	FILE *fp;
+	ccb_header header;
+	
+	memcpy(header.magic, CCB_MAGIC, sizeof(header.magic));
+	header.version = CCB_VERSION;
+	header.token_size = sizeof(token);
+	header.name_size = sizeof(var_names[0]);
+	header.tokens_cnt = t;
+	header.vars_cnt = var_cnt;
+	header.checksum = hash_bytes(hash_bytes(FNV_OFFSET, (char *) tokens, t * sizeof(token)), (char *) var_names, var_cnt * sizeof(var_names[0]));
+	
+	if ((fp = fopen(fname, "wb")) == NULL) {
+		puts("Problem with provided output file name:");
+		puts(strerror(errno));
+		return 0;
+	}
+	
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(tokens, sizeof(token), t, fp);
+	fwrite(var_names, sizeof(var_names[0]), var_cnt, fp);
+	fclose(fp);
+	
+	printf("File %s has been created.\n", fname);
+	return 1;
+}
+
+/*Map a precompiled program file in memory, returns the number of tokens or -1 if the file is not valid*/
+int load_program (char *fname, token **tokens) {
+	int fd;
+	int i, j;
+	int t;
+	int valid = 1;
+	struct stat st;
+	char *map;
+	ccb_header *header;
+	token *program;
+	
+	if ((fd = open(fname, O_RDONLY)) == -1) {
+		printf("%s\n", strerror(errno));
+		return -1;
+	}
+	
+	if (fstat(fd, &st) == -1) {
+		printf("%s\n", strerror(errno));
+		close(fd);
+		return -1;
+	}
+	
+	if (st.st_size < (off_t) sizeof(ccb_header)) {
+		close(fd);
+		printf("%s is not a precompiled program.\n", fname);
+		return -1;
+	}
+	
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //the mapping stays valid after the file is closed
+	
+	if (map == MAP_FAILED) {
+		printf("%s\n", strerror(errno));
+		return -1;
+	}
+	
+	ccb_map = map;
+	ccb_size = st.st_size;
+	header = (ccb_header *) map;
+	
+	/*Check the header, so the rest of the file can be used without copying it*/
+	if (memcmp(header->magic, CCB_MAGIC, sizeof(header->magic)) != 0) {
+		printf("%s is not a precompiled program.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	if (header->version != CCB_VERSION || header->token_size != sizeof(token) || header->name_size != sizeof(var_names[0])) {
+		printf("%s has been precompiled by an incompatible version of the translator.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	if (header->tokens_cnt < 2 || header->tokens_cnt > MAX_TOKENS || header->vars_cnt < 1 || header->vars_cnt > MAX_VARS ||
+		st.st_size != (off_t) (sizeof(ccb_header) + header->tokens_cnt * sizeof(token) + header->vars_cnt * sizeof(var_names[0]))) {
+		printf("%s is corrupted.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	program = (token *) (map + sizeof(ccb_header));
+	var_names = (char (*)[MAX_NAME_LEN + 2]) (map + sizeof(ccb_header) + header->tokens_cnt * sizeof(token));
+	var_cnt = header->vars_cnt;
+	
+	if (hash_bytes(hash_bytes(FNV_OFFSET, (char *) program, header->tokens_cnt * sizeof(token)), (char *) var_names, var_cnt * sizeof(var_names[0])) != header->checksum) {
+		printf("%s is corrupted, checksum mismatch.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	/*The checksum can be forged, so check everything the code generation relies on, as if the file was written by anyone*/
+	
+	/*The names are pasted in the generated code, so they must be [a-z]{1,31} with an optional '_' for the reserved names*/
+	for (i = 0; i < var_cnt; ++i) {
+		for (j = 0; var_names[i][j] >= 'a' && var_names[i][j] <= 'z' && j < MAX_NAME_LEN; ++j);
+		
+		if (var_names[i][j] == '_') {
+			++j;
+		}
+		
+		if (j == 0 || var_names[i][j] != '\0') {
+			printf("%s is corrupted.\n", fname);
+			unload_program();
+			return -1;
+		}
+	}
+	
+	if (strcmp(var_names[RESULT_VAR], "result") != 0) {
+		printf("%s is corrupted.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	/*The ids index the names and the arrays of the code generation, and the program must end like analize_tokens leaves it*/
+	t = header->tokens_cnt;
+	for (i = 0; i < t && valid; ++i) {
+		switch (program[i].type) {
+			case variable: //t_assign is only allowed on variables
+				valid = ((program[i].operation >= t_plus && program[i].operation <= t_mod) || program[i].operation == t_assign) && program[i].data.id >= 0 && program[i].data.id < var_cnt;
+				break;
+			case literal: //t_shl and t_shr are only produced by the optimization of literals
+				valid = program[i].operation >= t_plus && program[i].operation <= t_shr;
+				break;
+			case eop: //t_end is only allowed on the eop, at the end of the program
+				valid = program[i].operation == t_end && i == t - 1;
+				break;
+			default:
+				valid = 0;
+		}
+	}
+	
+	if (!valid || program[t-1].type != eop || program[t-2].type != variable || program[t-2].operation != t_assign || program[t-2].data.id != RESULT_VAR) {
+		printf("%s is corrupted.\n", fname);
+		unload_program();
+		return -1;
+	}
+	
+	*tokens = program;
+	return t;
+}
+
+/*Unmap the last loaded precompiled program*/
+void unload_program (void) {
+	if (ccb_map != NULL) {
+		munmap(ccb_map, ccb_size);
+		ccb_map = NULL;
+		ccb_size = 0;
+	}
+	
+	/*Go back to the symbol table of the translator*/
+	var_names = var_names_table;
+	var_cnt = 1;
+}
+
+/*Log a diagnostic to the global diagnostics log*/
+void log_diagnostic (diagnostic_code code, int line, char *text) {
+	if (error_cnt < max_errors) { //if the log is full only count the diagnostic
+		diagnostics[error_cnt].code = code;
+		diagnostics[error_cnt].line = line;
+		
+		if (text != NULL) { //keep only an excerpt of the text, so the log stays small
+			diagnostics[error_cnt].text_len = strlen(text);
+			strncpy(diagnostics[error_cnt].text, text, EXCERPT_LEN);
+			diagnostics[error_cnt].text[EXCERPT_LEN] = '\0';
+		}
+	}
+	++error_cnt;
+}
+
+/*Print the logged diagnostics*/
+void print_diagnostics (void) {
+	int i;
+	
+	for (i = 0; i < error_cnt && i < max_errors; ++i) {
+		switch (diagnostics[i].code) {
+			case e_unrecognised_token:
+				printf("%d: error: unrecognised token `%s%s`\n", diagnostics[i].line, diagnostics[i].text, diagnostics[i].text_len > EXCERPT_LEN ? "..." : "");
+				break;
+			case e_missing_eop:
+				printf("%d: error: end_of_program token is missing. Autoassign at line %d\n", diagnostics[i].line, diagnostics[i].line);
+				break;
+			case w_division_by_zero:
+				printf("%d: warning: division by zero\n", diagnostics[i].line);
+				break;
+			case w_unreachable_code:
+				printf("%d: warning: unreachable code detected\n", diagnostics[i].line);
+				break;
+		}
+	}
+	
+	if (error_cnt > max_errors) {
+		printf("%d more errors and warnings not shown\n", error_cnt - max_errors);
+	}
+	putchar('\n');
+}
+
 /*Analize the code to detect syndax errors, unreachable code etc*/
 int analize_tokens (token *tokens, int t) {
 	int i;
@@ -455,9 +1036,8 @@ int analize_tokens (token *tokens, int t) {
 	/*Detect division by zero*/
 	for (i = 0; i < t; ++i) {
 		if (tokens[i].type == literal && (tokens[i].operation == t_div || tokens[i].operation == t_mod) && tokens[i].data.value == 0) {
-			//log the warning to the global error buffer
-			sprintf(&error_buffer[error_cnt], "%d: warning: division by zero\n", i + removed_lines);
-			error_cnt += strlen(&error_buffer[error_cnt]);
+			//log the warning to the global diagnostics log
+			log_diagnostic(w_division_by_zero, i + removed_lines, NULL);
 		}
 	}
 	
@@ -472,20 +1052,19 @@ int analize_tokens (token *tokens, int t) {
 	}
 	
 	if (e == 0) { //eop is missing
-		//log the error to the global error buffer
-		sprintf(&error_buffer[error_cnt], "%d: error: end_of_program token is missing. Autoassign at line %d\n", i + removed_lines, i + removed_lines);
-		error_cnt += strlen(&error_buffer[error_cnt]);
+		//log the error to the global diagnostics log
+		log_diagnostic(e_missing_eop, i + removed_lines, NULL);
 		
 		/*Assign eop token at the end of the program*/
 		tokens[i].type = eop;
 		tokens[i].operation = t_end;
+		tokens[i].data.value = 0;
 		
 		t = i + 1; //update tokens counter
 	}
 	else if (t > i + 1) { //then we have unreachable code at position i + 1
-		//log the error to the global error buffer
-		sprintf(&error_buffer[error_cnt], "%d: warning: unreachable code detected\n", i + removed_lines + 1);
-		error_cnt += strlen(&error_buffer[error_cnt]);
+		//log the warning to the global diagnostics log
+		log_diagnostic(w_unreachable_code, i + removed_lines + 1, NULL);
 		
 		t = i + 1; //drop the unreachable code
 	}
@@ -494,10 +1073,11 @@ int analize_tokens (token *tokens, int t) {
 	/*Add result variable assignment at the end of the program*/
 	tokens[++t-1].type = eop;
 	tokens[t-1].operation = t_end;
+	tokens[t-1].data.value = 0;
 	
 	tokens[t-2].type = variable;
 	tokens[t-2].operation = t_assign;
-	tokens[t-2].data.name = '$'; //result variable is symbolized with the dollar sign
+	tokens[t-2].data.id = RESULT_VAR; //result variable has its own reserved id
 	
 	return t;
 }
@@ -505,7 +1085,7 @@ int analize_tokens (token *tokens, int t) {
 
 int optimize_tokens (token *tokens, int t) {
 	int i, z, k;
-	token tokens_tmp[500];
+	token tokens_tmp[MAX_TOKENS];
 
 	/*Drop all lines before last '* 0'*/
 	for (i = 0, z = -1; i < t; ++i) {
@@ -550,7 +1130,7 @@ int optimize_tokens (token *tokens, int t) {
 }
 
 /*Checks if an integer is power for two from 0 to 10*/
-inline int is_power_of_2 (int x) {
+static inline int is_power_of_2 (int x) {
 	if (x == 1 || x == 2 || x == 4 || x == 8 || x == 16 || x == 32 || x == 64 || x == 128 || x == 256 || x == 512 || x == 1024) {
 		return 1;
 	}
@@ -576,43 +1156,39 @@ int generate_assignments (token *tokens, int t, char *assign_buff) {
 	int last_assign = 0;
 	int last_assign_with_data = -1;
 	int a = 0; //assignment counter
-	int k = 0; //assignment counter 
-	char assignments[500][256];
+	int k = 0; //assign_buff counter
 	char code_token[50];
-	char var_array[300];
+	int var_array[MAX_TOKENS]; //the id of the variable of each assignment
 	int v = 0;
-	char vars_with_data[300];
-	char *vp; //var pointer 
+	int vars_with_data[MAX_TOKENS]; //ids of the variables that have data, -1 for unlogged variables
+	int var_pos[MAX_VARS]; //position of each variable inside vars_with_data, -1 if not logged
+	
+	for (i = 0; i < var_cnt; ++i) {
+		var_pos[i] = -1;
+	}
 	
 	/*Generate the assignments to the variables*/
 	for (i = 0; i < t; ++i) {
 		if (tokens[i].operation == t_assign) { //then assign it, all the above tokens
-			var_array[a] = tokens[i].data.name; //log the assignment
+			var_array[a] = tokens[i].data.id; //log the assignment
 			
-			/*Begin the assignment line with the variable*/
-			if (tokens[i].data.name != '$') { //if we have an ordinary variable
-				assignments[a][k++] = '\n';
-				assignments[a][k++] = '\t';
-				assignments[a][k++] = tokens[i].data.name;
-			}
-			else {
-				assignments[a][k++] = '\n';
-				assignments[a][k++] = '\t';
-				strcpy(&assignments[a][k], "result"); //if we reached the default variable
-				k += strlen(&assignments[a][k]);
-			}
+			/*Begin the assignment line with the variable, the default variable is interned as result*/
+			assign_buff[k++] = '\n';
+			assign_buff[k++] = '\t';
+			strcpy(&assign_buff[k], var_names[var_array[a]]);
+			k += strlen(&assign_buff[k]);
 			
 			/*Next we have the assign operator*/
-			assignments[a][k++] = ' ';
-			assignments[a][k++] = '=';
-			assignments[a][k++] = ' ';
+			assign_buff[k++] = ' ';
+			assign_buff[k++] = '=';
+			assign_buff[k++] = ' ';
 			
 			/*Put as many brackets on the start as the total operations in the assignment - 1*/
-			for (j = last_assign; j + 1 < i; ++j, assignments[a][k++] = '(');
+			for (j = last_assign; j + 1 < i; ++j, assign_buff[k++] = '(');
 			
 			/*If we have don't have +- at the start of the assignment put a zero*/
 			if (tokens[last_assign].operation != t_plus && tokens[last_assign].operation != t_min) {
-				assignments[a][k++] = '0';
+				assign_buff[k++] = '0';
 			}
 			
 			/*Convert the tokens to code*/
@@ -624,57 +1200,54 @@ int generate_assignments (token *tokens, int t, char *assign_buff) {
 					token_to_code(tokens[j], code_token, NO_BRACKET); //don't put bracket to the last operation
 				}
 				
-				strcpy(&assignments[a][k], code_token);
-				k += strlen(&assignments[a][k]);
+				strcpy(&assign_buff[k], code_token);
+				k += strlen(&assign_buff[k]);
 			}
 
 			/*If the assignment has no operation in it*/
 			if (last_assign >= i) { //this happens when we have 2 '= variable' in a row inside the code
-				//assignments[a][k++] = '0';
-				
 				//if this var has previously logged that has data 
-				if ((vp = strchr(vars_with_data, var_array[a])) != NULL) { //then unlog var
-					*vp = '!';
+				if (var_pos[var_array[a]] != -1) { //then unlog var
+					vars_with_data[var_pos[var_array[a]]] = -1;
+					var_pos[var_array[a]] = -1;
 				}
 			}
 			else {
 				last_assign_with_data = a; //detect the last assignment with data
-				if (strchr(vars_with_data, var_array[a]) == NULL) { //then unlog var
+				if (var_pos[var_array[a]] == -1) { //then log var
+					var_pos[var_array[a]] = v;
 					vars_with_data[v++] = var_array[a]; //this var has data
 				}
 			}
 			
 			/*Put the semicolon at the end of the assignment*/
-			assignments[a++][k] = ';';
+			assign_buff[k++] = ';';
+			++a;
 			
-			k = 0;
 			last_assign = i + 1;
 		}
 	}
 	
 	/*If we have assignments without data, put the last assignment with data in the result variable*/
 	if (last_assign_with_data != -1 && last_assign_with_data != a - 1) {
-		k = strlen(assignments[a-1]);
-		
+		k -= 2; //the last assignment ends with "0;", overwrite them
 		
 		for (i = v - 1; i >= 0; --i) {
-			if (vars_with_data[i] != '!') {
+			if (vars_with_data[i] != -1) {
 				break;
 			}
 		}
 		
 		if (i == -1) { //then there is no variable with data
-			assignments[a-1][k-2] = '0';
+			assign_buff[k++] = '0';
 		}
 		else {
-			assignments[a-1][k-2] = vars_with_data[i];
+			strcpy(&assign_buff[k], var_names[vars_with_data[i]]);
+			k += strlen(&assign_buff[k]);
 		}
+		assign_buff[k++] = ';';
 	}
 	
-	for (i = 0, k = 0; i < a; ++i) {
-		strcpy(&assign_buff[k], assignments[i]);
-		k += strlen(&assign_buff[k]);
-	}
 	assign_buff[k] = '\0';
 	
 	return 1;
@@ -715,7 +1288,8 @@ void token_to_code(token tkn, char *code_token, int put_bracket) {
 		i = strlen(code_token);
 	}
 	else {
-		code_token[i++] = tkn.data.name;
+		strcpy(&code_token[i], var_names[tkn.data.id]);
+		i += strlen(&code_token[i]);
 	}
 	
 	if (put_bracket) {
@@ -727,11 +1301,10 @@ void token_to_code(token tkn, char *code_token, int put_bracket) {
 
 /*Generates C code based on a tokens array*/
 int generate_code (char *buffer, token *tokens, int t) {
-	char assignments[10000];
+	char assignments[CODE_SIZE];
 	int k = 0; //buffer counter
-	char used_var[300];
+	char used_var[MAX_VARS] = {0}; //flag for each variable id, set once it has been declared
 	int i;
-	int j = 0;
 	
 	/*Generate the assignmets lines of code*/
 	generate_assignments(tokens, t, assignments);
@@ -742,11 +1315,12 @@ int generate_code (char *buffer, token *tokens, int t) {
 	
 	/*Generate the variable definition*/
 	for (i = 0; i < t; ++i) {
-		if (tokens[i].operation == t_assign && strchr(used_var, tokens[i].data.name) == NULL) {
-			used_var[j++] = tokens[i].data.name; //log variable as used
+		if (tokens[i].operation == t_assign && !used_var[tokens[i].data.id]) {
+			used_var[tokens[i].data.id] = 1; //log variable as used
 			
-			if (tokens[i].data.name != '$') {
-				buffer[k++] = tokens[i].data.name;
+			if (tokens[i].data.id != RESULT_VAR) {
+				strcpy(&buffer[k], var_names[tokens[i].data.id]);
+				k += strlen(&buffer[k]);
 				buffer[k++] = ',';
 				buffer[k++] = ' ';
 			}
@@ -769,23 +1343,31 @@ int generate_code (char *buffer, token *tokens, int t) {
 
 /*Save users code on an output file*/
 int save_code(char *buffer, char *fname) {
-	FILE *fp;
-	
-	if ((fp = fopen(fname, "w")) == NULL) { //if failed with fname provided by the user
+	if (!write_code(buffer, fname)) { //if failed with fname provided by the user
 		puts("Problem with provided output file name:");
 		puts(strerror(errno));
 		strcpy(fname, "out.c");
 		
-		if ((fp = fopen(fname, "w")) == NULL) { //try again with out.c
+		if (!write_code(buffer, fname)) { //try again with out.c
 			puts(strerror(errno));
 			return 0;
 		}
 	}
 
+	printf("File %s has been created.\n", fname);
+	return 1;
+}
+
+/*Write the code on a file, without any fallback or messages*/
+int write_code (char *buffer, char *fname) {
+	FILE *fp;
+	
+	if ((fp = fopen(fname, "w")) == NULL) {
+		return 0;
+	}
+	
 	fputs(buffer, fp);
 	fclose(fp);
-
-	printf("File %s has been created.\n", fname);
 	return 1;
 }
 